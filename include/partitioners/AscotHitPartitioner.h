@@ -0,0 +1,42 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "PetscExternalPartitioner.h"
+
+/**
+ * Partitions the mesh with PETSc, weighing each element by the number of ASCOT5 markers that hit
+ * it in the last run, as published by an AscotProblem to its hit_weight_integer. Fast-ion loads
+ * are localized on a few wall tiles, so the ranks owning them otherwise do most of the work. The
+ * hit weights are blended with the element count through a constant weight per element.
+ */
+class AscotHitPartitioner : public PetscExternalPartitioner
+{
+public:
+  static InputParameters validParams();
+
+  AscotHitPartitioner(const InputParameters & parameters);
+
+  virtual std::unique_ptr<Partitioner> clone() const override;
+
+  virtual void initialize(MeshBase & mesh) override;
+
+  virtual dof_id_type computeElementWeight(Elem & elem) override;
+
+protected:
+  /// The extra element integer holding the hits on each element
+  const std::string & _hit_integer;
+  /// The weight of every element, whatever its hits
+  const Real _element_weight;
+  /// The weight of each marker hit
+  const Real _hit_weight;
+  /// The index of _hit_integer (libMesh::invalid_uint until an AscotProblem adds it)
+  unsigned int _hit_integer_index;
+};
@@ -0,0 +1,39 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "GeneralPostprocessor.h"
+
+class AscotProblem;
+
+/**
+ * Reports a statistic of the markers and HDF5 I/O of an AscotProblem, summed (or, for memory,
+ * maximised) over all ranks.
+ */
+class AscotProblemStatistic : public GeneralPostprocessor
+{
+public:
+  static InputParameters validParams();
+
+  AscotProblemStatistic(const InputParameters & parameters);
+
+  virtual void initialize() override {}
+  virtual void execute() override;
+  virtual void finalize() override;
+  virtual Real getValue() override;
+
+protected:
+  /// The problem the statistic is taken from
+  const AscotProblem * const _ascot_problem;
+  /// The statistic to report
+  const MooseEnum _statistic;
+  /// The value of the statistic
+  Real _value;
+};
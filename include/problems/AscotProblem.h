@@ -12,12 +12,16 @@
 #include "ExternalProblem.h"
 #include "PhaethonApp.h"
 #include "H5Cpp.h"
-
-namespace constants
-{
-const double_t c = 299792458.0;
-const double_t amu = 1.6605390666e-27;
-}
+#include "Ascot5Api.h"
+#include "Ascot5Session.h"
+#include "AscotConstants.h"
+#include "AscotMarkerStore.h"
+#include "AscotKernels.h"
+#include "H5TypeTraits.h"
+#include <array>
+#include <list>
+#include <map>
+#include <future>
 
 class AscotProblem : public ExternalProblem
 {
@@ -34,6 +38,13 @@ public:
    */
   virtual bool converged() override;
 
+  virtual void initialSetup() override;
+
+  /**
+   * The wall tile geometry and dof map are cached, so they are rebuilt whenever the mesh changes.
+   */
+  virtual void meshChanged() override;
+
   /**
    * New interface for solving an External problem. "solve()" is finalized here to provide
    * callbacks for solution syncing.
@@ -45,6 +56,12 @@ public:
    */
   virtual void syncSolutions(Direction direction) override;
 
+  /**
+   * With the lagged coupling, waits for the background ASCOT5 run before checkpoints and the
+   * final output, so they are consistent with the HDF5 file.
+   */
+  virtual void outputStep(ExecFlagType type) override;
+
   /**
    * Method called to add AuxVariables to the simulation. These variables would be the fields
    * that should either be saved out with the MOOSE-formatted solutions or available for
@@ -68,6 +85,89 @@ public:
    */
   static H5::Group getAscotH5Group(const H5::H5File & hdf5_file, const std::string & group_name);
 
+  /**
+   * @brief Get the name of the active sub-group of a top-level ASCOT5 group
+   *
+   * @param hdf5_file the ASCOT5 HDF5 file with input and output data.
+   * @param group_name the top-level group, e.g. "marker" or "results"
+   * @return std::string the sub-group the 'active' attribute points to, e.g. "prt_0000000002"
+   */
+  static std::string getActiveGroupName(const H5::H5File & hdf5_file,
+                                        const std::string & group_name);
+
+  /**
+   * @brief Delete a group from an HDF5 file, optionally copying it to an archive file first
+   *
+   * @param hdf5_file the file to delete the group from
+   * @param group_path the path of the group, e.g. "marker/prt_0000000002"
+   * @param archive_file_name the file the group is copied to under the same path (created if it
+   * does not exist), or empty to not archive it
+   */
+  static void archiveAndDeleteGroup(const H5::H5File & hdf5_file,
+                                    const std::string & group_path,
+                                    const std::string & archive_file_name);
+
+  /**
+   * @brief Rewrite an HDF5 file without the space left behind by deleted groups
+   *
+   * HDF5 does not return the space of deleted objects to the file system, so every top-level
+   * object is copied to a fresh file, which then replaces the original. The file must not be open.
+   *
+   * @param file_name the HDF5 file to compact
+   */
+  static void compactH5File(const std::string & file_name);
+
+  /**
+   * @brief Read one vertex coordinate of all the triangles of an ASCOT5 3D wall
+   *
+   * @param wall_group the wall_3D group
+   * @param field_name the dataset, e.g. "x1x2x3"
+   * @param coordinates the coordinate of the three vertices of each triangle in turn (output)
+   */
+  static void readWallCoordinates(H5::Group & wall_group,
+                                  const std::string & field_name,
+                                  std::vector<double_t> & coordinates);
+
+  /**
+   * @brief The sample points of a triangle split into refinement^2 equal sub-triangles
+   *
+   * @param refinement the number of divisions of each triangle edge
+   * @return std::vector<std::pair<double_t, double_t>> the barycentric coordinates (along the
+   * second and third vertices) of the centroid of each sub-triangle, each standing for
+   * 1 / refinement^2 of the triangle's area
+   */
+  static std::vector<std::pair<double_t, double_t>> triangleSamples(unsigned int refinement);
+
+  /**
+   * @brief Hash the vertex coordinates of an ASCOT5 3D wall
+   *
+   * @param x1x2x3 the x coordinates of the three vertices of each triangle in turn
+   * @param y1y2y3 the y coordinates of the three vertices of each triangle in turn
+   * @param z1z2z3 the z coordinates of the three vertices of each triangle in turn
+   * @return uint64_t the 64-bit FNV-1a hash of the coordinates
+   */
+  static uint64_t wallHash(const std::vector<double_t> & x1x2x3,
+                           const std::vector<double_t> & y1y2y3,
+                           const std::vector<double_t> & z1z2z3);
+
+  /**
+   * @brief Write triangles to an HDF5 file as the active ASCOT5 3D wall
+   *
+   * The wall_3D group is tagged with the hash of its coordinates and its id is derived from the
+   * hash. Nothing is written if the active wall has the same hash, and a wall written before is
+   * only made active again.
+   *
+   * @param hdf5_file the ASCOT5 HDF5 file
+   * @param x1x2x3 the x coordinates of the three vertices of each triangle in turn
+   * @param y1y2y3 the y coordinates of the three vertices of each triangle in turn
+   * @param z1z2z3 the z coordinates of the three vertices of each triangle in turn
+   * @return bool whether the active wall changed
+   */
+  static bool writeWall(const H5::H5File & hdf5_file,
+                        const std::vector<double_t> & x1x2x3,
+                        const std::vector<double_t> & y1y2y3,
+                        const std::vector<double_t> & z1z2z3);
+
   /**
    * @brief Get an Ascot HDF5 Data object
    *
@@ -80,6 +180,19 @@ public:
   static std::vector<T> getAscotH5DataField(H5::Group & endstate_group,
                                             const std::string & field_name);
 
+  /**
+   * @brief Read an Ascot HDF5 Data object into an existing buffer
+   *
+   * @tparam T type of the data object
+   * @param endstate_group the group in which the data object sits
+   * @param field_name the name of the data object in the HDF5 file
+   * @param marker_data the buffer to read into; it is resized to the number of markers
+   */
+  template <class T>
+  static void readAscotH5DataField(H5::Group & endstate_group,
+                                   const std::string & field_name,
+                                   std::vector<T> & marker_data);
+
   /**
    * @brief Set an Ascot HDF5 Data object
    *
@@ -98,12 +211,15 @@ public:
    * @param name the name of the data field in the HDF5 file
    * @param data_space the HDF5 DataSpace for the DataSet
    * @param group the HDF5 Group in which the DataSet will be created
+   * @param properties the creation properties (layout, chunking and filters) of the DataSet
    */
   template <class T>
-  static void createAndWriteDataset(const std::vector<T> & data,
-                                    const std::string & name,
-                                    const H5::DataSpace & data_space,
-                                    const H5::Group & group);
+  static void
+  createAndWriteDataset(const std::vector<T> & data,
+                        const std::string & name,
+                        const H5::DataSpace & data_space,
+                        const H5::Group & group,
+                        const H5::DSetCreatPropList & properties = H5::DSetCreatPropList::DEFAULT);
 
   /**
    * @brief Copy the ASCOT5 endstate data members to the marker group in the HDF5 file
@@ -114,24 +230,134 @@ public:
   void copyEndstate2MarkerGroup(const H5::H5File & hdf5_file);
 
   /**
-   * @brief Get the Double type Ascot Endstate Variables from HDF5 File
+   * @brief Write markers to a new marker group in the HDF5 file and make it the active one
+   *
+   * @param hdf5_file the ASCOT5 HDF5 file
+   * @param markers the markers to write
+   */
+  void writeMarkerGroup(const H5::H5File & hdf5_file, const AscotMarkers & markers);
+
+  /**
+   * @brief Create a new marker group for the next time step and make it the active one
+   *
+   * The datasets of all the marker fields are created with room for n_markers markers, to be
+   * written with writeMarkerColumn.
+   *
+   * @param hdf5_file the ASCOT5 HDF5 file
+   * @param n_markers the number of markers in the group
+   * @return H5::Group the new marker group
+   */
+  H5::Group createMarkerGroup(const H5::H5File & hdf5_file, hsize_t n_markers);
+
+  /**
+   * @brief Write a contiguous block of the values of one field to a marker group
+   *
+   * @tparam T the type of the field
+   * @param marker_group the marker group made by createMarkerGroup
+   * @param field_name the name of the marker field
+   * @param offset the index of the first marker of the block
+   * @param column the values of the field for the markers of the block
+   */
+  template <typename T>
+  static void writeMarkerColumn(H5::Group & marker_group,
+                                const std::string & field_name,
+                                hsize_t offset,
+                                const std::vector<T> & column);
+
+  /**
+   * @brief The name of the dataset of a marker field in the marker group
+   *
+   * ASCOT5 names some of the marker datasets without the 'prt' of the endstate field names.
+   */
+  static std::string markerDatasetName(const std::string & field_name);
+
+  /**
+   * @brief Write the active markers of the endstate streamed in the last run to a new marker group
+   *
+   * The endstate is not kept in memory when it is streamed, so each ASCOT5 rank reads it back from
+   * its output in blocks of _endstate_block_size markers, counting the active markers first from
+   * their end conditions only. The population control is then applied block by block with the
+   * comb of AscotKernels::populationComb, and the kept markers are written straight into the new
+   * marker group by the first rank, which receives those of the other ASCOT5 ranks in rank order.
+   * Called on all ranks.
+   */
+  void streamMarkerGroup();
+
+  /// The seed of the population control of this rank on this time step
+  uint64_t populationSeed() const;
+
+  /**
+   * @brief Filter the endstate down to the markers that are still active
+   *
+   * Markers with an end condition of 1 reached the end of the simulation time and are carried
+   * over to the next time step; all others have terminated. With marker_target, the active
+   * markers are then split or rouletted toward this rank's share of the target. The filtered
+   * fields are stored in active_markers, whose buffers are reused.
+   *
+   * @return size_t the number of active markers
+   */
+  size_t filterActiveMarkers();
+
+  /**
+   * @brief Stream the endstate of the last run in blocks of _endstate_block_size markers
+   *
+   * The power on each wall tile and the tallies are summed block by block, while the next block
+   * is read in the background into the other block buffer. No markers are kept; the active ones
+   * are read back from the endstate by streamMarkerGroup when ASCOT5 is restarted.
+   *
+   * @param endstate_group the HDF5 file group where the endstate lives
+   * @return size_t the number of markers still active
+   */
+  size_t streamEndstate(H5::Group & endstate_group);
+
+  /**
+   * @brief Repartition the mesh with the partitioner of the Mesh block and remap the wall tiles
+   *
+   * Run before an ASCOT5 run, since the heat fluxes of earlier runs are dropped as on any mesh
+   * change.
+   */
+  void repartitionMesh();
+
+  /**
+   * @brief Read all Ascot Endstate Variables from HDF5 File in a single pass
+   *
+   * Each dataset in the endstate group is read exactly once, straight into the (reused) buffers
+   * of the marker store.
+   *
+   * @param endstate_group the HDF5 file group where the endstate lives
+   * @param endstate the marker store to fill
+   */
+  static void readEndstate(H5::Group & endstate_group, AscotEndstate & endstate);
+
+  /**
+   * @brief Read a contiguous block of markers of the endstate through hyperslab selections
    *
    * @param endstate_group the HDF5 file group where the endstate lives
-   * @return std::unordered_map<std::string, std::vector<double_t>> the variables of type double_t
-   * in the endstate
+   * @param offset the index of the first marker of the block
+   * @param count the number of markers in the block
+   * @param block the marker store to fill, whose buffers are reused
    */
-  static std::unordered_map<std::string, std::vector<double_t>>
-  getAscotH5EndstateDouble(H5::Group & endstate_group);
+  static void readEndstateBlock(H5::Group & endstate_group,
+                                hsize_t offset,
+                                hsize_t count,
+                                AscotEndstate & block);
 
   /**
-   * @brief Get the Integer type Ascot Endstate Variables from HDF5 File
+   * @brief Read a contiguous block of the values of one field of the endstate
    *
+   * @tparam T the type of the field
    * @param endstate_group the HDF5 file group where the endstate lives
-   * @return std::unordered_map<std::string, std::vector<double_t>> the variables of type int64_t in
-   * the endstate
+   * @param field_name the name of the field
+   * @param offset the index of the first marker of the block
+   * @param count the number of markers in the block
+   * @param column the values read (resized to count)
    */
-  static std::unordered_map<std::string, std::vector<int64_t>>
-  getAscotH5EndstateInt(H5::Group & endstate_group);
+  template <typename T>
+  static void readEndstateColumn(H5::Group & endstate_group,
+                                 const std::string & field_name,
+                                 hsize_t offset,
+                                 hsize_t count,
+                                 std::vector<T> & column);
 
   /**
    * @brief Get the indices of wall tiles that each particle has collided with
@@ -161,6 +387,14 @@ public:
    */
   static std::vector<double_t> getParticleEnergies(H5::Group & endstate_group);
 
+  /**
+   * @brief Get the Particle Energies from an endstate that has already been read
+   *
+   * @param endstate the endstate marker store
+   * @param energies the particles energies in Joules, resized to the number of markers
+   */
+  static void getParticleEnergies(const AscotEndstate & endstate, std::vector<double_t> & energies);
+
   /**
    * @brief Calculate the relativistic energy for a particle from velocities
    *
@@ -168,24 +402,319 @@ public:
    * @param velocity the particle's velocity vector in m/s.
    * @return double_t the particle's energy in Joules
    */
-  static double_t calculateRelativisticEnergy(double_t mass, std::vector<double_t> velocity);
+  static double_t calculateRelativisticEnergy(double_t mass,
+                                              const std::vector<double_t> & velocity);
 
   /**
    * @brief Calculate the heat flux values on each element of the mesh
    *
-   * @param walltile the mesh element index that each marker has hit
+   * This is the reference implementation, working from precomputed marker energies. The time
+   * stepping uses the fused batch kernel in the endstate overload below. When run in parallel,
+   * only the fluxes on the elements owned by this rank are set; all others are zero.
+   *
+   * @param walltile the wall tile that each marker has hit
    * @param energies the energies of the markers in Joules
    * @param weights the marker weights in units of markers/s
-   * @return std::vector<double_t> the heat flux incident on each element of the wall mesh in units
-   * of W/m^2
+   * @return std::vector<double_t> the heat flux incident on each element, by element id, in
+   * units of W/m^2
    */
-  std::vector<double_t> calculateHeatFluxes(std::vector<int64_t> walltile,
-                                            std::vector<double_t> energies,
-                                            std::vector<double_t> weights);
+  std::vector<double_t> calculateHeatFluxes(const std::vector<int64_t> & walltile,
+                                            const std::vector<double_t> & energies,
+                                            const std::vector<double_t> & weights);
 
-  // Endstate variables required for restarting ASCOT5
-  std::unordered_map<std::string, std::vector<double_t>> endstate_data_double;
-  std::unordered_map<std::string, std::vector<int64_t>> endstate_data_int;
+  /**
+   * @brief Calculate the heat flux values on the elements of this rank from an endstate
+   *
+   * The marker energies and the power deposited on each wall tile are calculated in a single
+   * batched pass over the markers (see AscotKernels::depositPower).
+   *
+   * @param endstate the endstate markers
+   * @param elems the ids of the elements owned by this rank (output)
+   * @param heat_fluxes the heat flux incident on each of elems in units of W/m^2 (output)
+   */
+  void calculateHeatFluxes(const AscotEndstate & endstate,
+                           std::vector<dof_id_type> & elems,
+                           std::vector<double_t> & heat_fluxes);
+
+  /**
+   * @brief Convert the power on each wall tile to heat fluxes on the elements of this rank
+   *
+   * @param tile_power the power incident on each wall tile in W
+   * @param elems the ids of the elements of this rank (output)
+   * @param heat_fluxes the heat flux on each of elems in W/m^2 (output)
+   */
+  void localHeatFluxes(const std::vector<double_t> & tile_power,
+                       std::vector<dof_id_type> & elems,
+                       std::vector<double_t> & heat_fluxes) const;
+
+  /**
+   * @brief Send the power deposited on each wall tile to the ranks needing it
+   *
+   * Each ASCOT5 rank holds the power its markers deposited on every tile; it only sends the
+   * nonzero values, and only to the ranks whose elements overlap the tile. Each rank then sums
+   * the power on its tiles and converts it to heat fluxes on its elements, which the next
+   * syncSolutions sets. The wall tile map must have been built.
+   *
+   * @param tile_power the power this rank's markers deposited on each tile in W
+   * @param tile_power_squared the sum of the squared marker contributions to each tile in W^2
+   * @param tile_hits the number of markers that hit each tile, or empty if they are not counted
+   */
+  void distributeTilePower(const std::vector<double_t> & tile_power,
+                           const std::vector<double_t> & tile_power_squared,
+                           const std::vector<double_t> & tile_hits);
+
+  /// Statistics of the markers and HDF5 I/O on this rank
+  struct Statistics
+  {
+    /// Markers still active at the end of the last ASCOT5 run
+    std::size_t live_markers = 0;
+    /// Markers terminated (e.g. on the wall) in the last ASCOT5 run
+    std::size_t terminated_markers = 0;
+    /// Markers traced per second of wall time by the last ASCOT5 run
+    double_t markers_per_second = 0.0;
+    /// Bytes of marker data read from the ASCOT5 files so far
+    std::size_t bytes_read = 0;
+    /// Bytes of marker data written to the ASCOT5 files so far
+    std::size_t bytes_written = 0;
+    /// The largest memory held by the marker stores in bytes
+    std::size_t peak_marker_memory = 0;
+    /// The largest relative error of the heat flux on the hottest wall tiles (on all ranks)
+    double_t heat_flux_relative_error = 0.0;
+    /// The number of markers the next ASCOT5 run is sized to (on all ranks)
+    std::size_t marker_target = 0;
+    /// The number of times the ASCOT5 inputs (other than markers) were loaded on this rank
+    std::size_t ascot5_input_loads = 0;
+  };
+
+  const Statistics & statistics() const { return _statistics; }
+
+  /// The auxiliary variables the tallies are written to, which also name their spectra
+  const std::vector<VariableName> & tallyVariables() const { return _tally_variables; }
+
+  /// The edges of the energy bins of the spectra in eV
+  const std::vector<Real> & spectrumEnergies() const { return _spectrum_energies; }
+
+  /**
+   * @brief The particle rate of the markers of this rank in each energy bin, for each tally
+   *
+   * Laid out as spectra()[k * n_bins + b] for tally k and energy bin b; empty on ranks that do
+   * not run ASCOT5. Summed over the ranks, these are the wall impact spectra in markers/s.
+   */
+  const std::vector<double_t> & spectra() const { return _spectra; }
+
+  /**
+   * @brief The power of the nonzero heat fluxes synced to the local elements, e.g. for a sparse
+   * transfer that conserves power between meshes
+   *
+   * @param elems the ids of the local elements with a nonzero heat flux (output)
+   * @param power the heat flux on each of elems times its area in W (output)
+   */
+  void nonzeroPower(std::vector<dof_id_type> & elems, std::vector<double_t> & power) const;
+
+  // Endstate variables of the last ASCOT5 run, required for restarting ASCOT5. Stored as
+  // restartable data, so a restart continues from the same markers without the HDF5 history.
+  AscotEndstate & endstate;
+
+  // Endstate variables of the markers that are still active, i.e. the next ASCOT5 input
+  AscotMarkers active_markers;
+
+protected:
+  /**
+   * @brief Cache the wall tile areas and the map from wall tiles to the dofs of sync_variable
+   *
+   * The wall mesh is static, so this is done once at setup (and again if the mesh changes)
+   * rather than every time step.
+   */
+  void buildWallTileMap();
+
+  /**
+   * @brief Read and check the tally parameters
+   */
+  void setupTallies();
+
+  /**
+   * @brief Send the tallies of each wall tile to the rank owning it and convert them to the
+   * tally quantities of the local tiles
+   */
+  void distributeTallies();
+
+  /**
+   * @brief Find the largest relative error of the heat flux on the hottest wall tiles
+   *
+   * With heat_flux_error_target, also rescales the marker target so that the next ASCOT5 run
+   * reaches the error target on the hottest tiles.
+   */
+  void updateHeatFluxError();
+
+  /**
+   * @brief Write the mesh to ascot5_file as the active ASCOT5 3D wall
+   *
+   * The wall tiles are numbered by element id, so the numbering does not depend on the
+   * partitioning. The elements are gathered on the first rank, which writes them unless the
+   * active wall already holds the same triangles.
+   */
+  void exportWall();
+
+  /**
+   * @brief Find the overlap areas of the active ASCOT5 3D wall triangles with the local elements
+   *
+   * Each wall triangle near this rank's elements is split into mapping_refinement^2 equal
+   * sub-triangles, and the area of each is given to the element found under its centroid by the
+   * mesh's point locator. Triangles beyond mapping_tolerance of every element overlap nothing.
+   *
+   * @param overlaps the (tile, overlap area) pairs of each local element, in tile order (output)
+   * @return dof_id_type the number of wall triangles
+   */
+  dof_id_type
+  computeWallOverlaps(std::vector<std::vector<std::pair<dof_id_type, double_t>>> & overlaps);
+
+  /**
+   * @brief Share values on the wall tiles between the local elements they overlap
+   *
+   * @param tile_values the value on each tile in _local_tiles
+   * @param element_values the sum of the shares of each local element (output)
+   * @param square_fractions whether to weight by the squared shares, e.g. for variances
+   */
+  void mapTilesToElements(const double_t * tile_values,
+                          std::vector<double_t> & element_values,
+                          bool square_fractions = false) const;
+
+  /// Whether this rank runs ASCOT5
+  bool isAscot5Rank() const { return processor_id() < _n_ascot5_ranks; }
+
+  /// The HDF5 file this rank's ASCOT5 process writes its results to
+  std::string ascot5OutputFileName() const;
+
+  /// The HDF5 file ASCOT5 loads its options, fields, plasma and wall from
+  const std::string & ascot5InputsFileName() const
+  {
+    return _shared_inputs.empty() ? _ascot5_file_name : _shared_inputs;
+  }
+
+  /**
+   * @brief Gather the active markers of all ASCOT5 ranks on the first rank, in rank order
+   */
+  void gatherActiveMarkers();
+
+  /**
+   * @brief Whether this time step's markers are written to a marker group in the HDF5 file
+   *
+   * Always true for the HDF5 marker handoff. For the in-memory handoff markers are only written
+   * every marker_output_interval time steps.
+   */
+  bool writeMarkerGroupThisStep() const;
+
+  /**
+   * @brief Fill the in-memory marker arrays passed to ASCOT5 from the active marker data
+   */
+  void setMarkerArrays();
+
+  /**
+   * @brief The data of a marker field in the type ASCOT5 takes it in
+   *
+   * @param column the field, which may be stored narrower than ASCOT5 takes it
+   * @param buffer the buffer a narrower field is widened into
+   * @return const T * the field itself if it has type T, otherwise the buffer
+   */
+  template <typename T, typename S>
+  static const T * handoffData(const std::vector<S> & column, std::vector<T> & buffer);
+
+  /**
+   * @brief The creation properties of the marker datasets, from hdf5_chunk_size and
+   * hdf5_compression_level
+   *
+   * @param n_markers the number of markers in the datasets
+   */
+  H5::DSetCreatPropList markerDatasetProperties(hsize_t n_markers) const;
+
+  /// Record the memory currently held by the marker stores if it is the most so far
+  void updatePeakMarkerMemory();
+
+  /// This rank's share of marker_target
+  size_t rankMarkerTarget() const;
+
+  /**
+   * @brief Find the largest marker id used so far on any rank, so split markers get unique ids
+   */
+  void updateNextMarkerId();
+
+  /**
+   * @brief Apply the retention policy to the sub-groups of a top-level group of an HDF5 file
+   *
+   * Records the active sub-group, then deletes (and optionally archives) the oldest sub-groups
+   * this problem has seen become active, keeping the last retain_groups of them. The active
+   * sub-group and groups that were in the file before the simulation are never deleted.
+   *
+   * @param hdf5_file the file to apply the policy to
+   * @param group_name the top-level group, "marker" or "results"
+   */
+  void retainGroups(const H5::H5File & hdf5_file, const std::string & group_name);
+
+  /// The archive file for groups that became active on the given time step
+  std::string archiveFileName(int t_step) const;
+
+  /// Whether this time step's HDF5 files are compacted
+  bool compactThisStep() const;
+
+  /**
+   * @brief The access properties of the ASCOT5 files, with the configured caches
+   */
+  H5::FileAccPropList fileAccessProperties() const;
+
+  /**
+   * @brief Get the open handle to ascot5_file, opening it if need be
+   *
+   * In SWMR mode a handle that is only read from is switched to SWMR write mode, so monitors
+   * can read the file while it is held; it is reopened when new objects are to be written.
+   *
+   * @param create_objects whether groups, datasets or attributes will be created
+   * @return H5::H5File & the handle
+   */
+  H5::H5File & ascot5File(bool create_objects);
+
+  /**
+   * @brief Close the handle to ascot5_file, e.g. before ASCOT5 runs on it
+   */
+  void releaseAscot5File();
+
+  /**
+   * @brief Run ASCOT5 on this rank's markers, blocking until it has finished
+   */
+  void runAscot5();
+
+  /**
+   * @brief Run ASCOT5 in the resident session of this rank's inputs, which is shared with the
+   * other problems in the process that load the same inputs, e.g. the same shared_inputs
+   *
+   * @param arguments the command line arguments of ASCOT5
+   */
+  void runAscot5Session(const std::vector<std::string> & arguments);
+
+  /**
+   * @brief Read the endstate of the last ASCOT5 run and sum the power it deposited on each tile
+   */
+  void readAscot5Results();
+
+  /**
+   * @brief Whether ASCOT5 runs this time step
+   *
+   * ASCOT5 runs on the first time step, after the mesh changed, once coupling_interval time steps
+   * have passed since the last run, and whenever a coupling postprocessor has changed by more
+   * than coupling_threshold relative to its value at the last run.
+   */
+  bool runAscot5ThisStep() const;
+
+  /**
+   * @brief Extrapolate the heat fluxes linearly in time from the last two ASCOT5 runs
+   */
+  void extrapolateHeatFluxes();
+
+  /**
+   * @brief Wait for the ASCOT5 run in the background (lagged coupling) and read its results
+   *
+   * @return whether there was a run to wait for
+   */
+  bool finishAscot5Run();
 
 private:
   /// The name of the AuxVariable to transfer to
@@ -194,10 +723,234 @@ private:
   AuxiliarySystem & _problem_system;
   /// The HDF5 file that is both the ASCOT5 input and output
   const FileName & _ascot5_file_name;
+  /// The handle to _ascot5_file_name the first rank keeps open between ASCOT5 runs
   H5::H5File _ascot5_file;
+  /// Whether markers are handed to ASCOT5 in memory rather than through the HDF5 file
+  const bool _memory_handoff;
+  /// Interval in time steps at which markers are still written to file for the memory handoff
+  const unsigned int _marker_output_interval;
+  /// Whether _marker_arrays holds the markers for the next ASCOT5 run
+  bool _marker_arrays_ready;
+  /// Pointers into the active marker data for the in-memory handoff to ASCOT5
+  ascot5::phaethon_marker_arrays _marker_arrays;
+  /// The fields of the in-memory handoff widened to the types of ASCOT5, when they are stored
+  /// in reduced precision
+  std::vector<double_t> _handoff_weight;
+  std::vector<int64_t> _handoff_charge;
+  std::vector<int64_t> _handoff_anum;
+  std::vector<int64_t> _handoff_znum;
+  /// The ASCOT5 file the inputs are shared from ("" if ascot5_file holds them)
+  const std::string _shared_inputs;
+  /// The ensemble whose tile powers this problem reports ("" if it is not in one)
+  const std::string _ensemble;
+  /// The index of this problem in _ensemble
+  const unsigned int _ensemble_member;
+  /// Whether the ASCOT5 inputs stay resident in a session between runs
+  const bool _persistent_session;
+  /// The resident ASCOT5 session of this rank (null until the first run)
+  std::shared_ptr<Ascot5Session> _ascot5_session;
+  /// The number of times the ASCOT5 inputs were loaded on this rank
+  std::size_t _ascot5_input_loads;
+  /// The end time of the next ASCOT5 run
+  double_t _ascot5_end_time;
+  /// Indices of the active markers in the endstate
+  std::vector<size_t> _active_indices;
+  /// The number of ranks ASCOT5 runs on
+  const processor_id_type _n_ascot5_ranks;
+  /// The number of OpenMP threads per ASCOT5 rank (0 for the OpenMP default)
+  const unsigned int _ascot5_threads;
+  /// The active markers of all ASCOT5 ranks (only on the first rank)
+  AscotMarkers _gathered_markers;
+  /// Whether ASCOT5 runs in the background, with the heat fluxes lagged by one time step
+  const bool _lagged_coupling;
+  /// Interval in time steps at which the lagged coupling waits for ASCOT5 within the time step
+  const unsigned int _lagged_sync_interval;
+  /// Whether the endstate and tile powers hold the results of a completed ASCOT5 run
+  bool _have_ascot5_results;
+  /// The ASCOT5 run in the background (lagged coupling only)
+  std::future<void> _ascot5_run;
+  /// The largest number of time steps between ASCOT5 runs
+  const unsigned int _coupling_interval;
+  /// Postprocessors whose change triggers an ASCOT5 run
+  const std::vector<PostprocessorName> _coupling_postprocessors;
+  /// The relative change in a coupling postprocessor that triggers an ASCOT5 run
+  const Real _coupling_threshold;
+  /// Whether the heat fluxes are extrapolated rather than held between ASCOT5 runs
+  const bool _extrapolate_heat_fluxes;
+  /// Whether ASCOT5 runs this time step
+  bool _run_ascot5;
+  /// Whether the tile powers hold results that have not been sent to the tile owners yet
+  bool _new_ascot5_results;
+  /// Whether the mesh changed since the last ASCOT5 run
+  bool _mesh_changed;
+  /// The time step of the last ASCOT5 run (0 before the first run)
+  int & _last_run_step;
+  /// The values of the coupling postprocessors at the last ASCOT5 run
+  std::vector<Real> & _last_coupling_values;
+  /// The local heat fluxes of the last ASCOT5 run and the one before, for extrapolation
+  std::vector<double_t> & _run_heat_fluxes;
+  std::vector<double_t> & _previous_heat_fluxes;
+  /// The times of the heat fluxes of the last ASCOT5 run and the one before
+  Real & _run_time;
+  Real & _previous_run_time;
+  /// The number of marker and results sub-groups kept in the HDF5 files (0 keeps all)
+  const unsigned int _retain_groups;
+  /// The base name of the files deleted groups are archived to (empty to not archive)
+  const std::string _archive_file_base;
+  /// Interval in time steps covered by each archive file
+  const unsigned int _archive_interval;
+  /// Interval in time steps at which the HDF5 files are compacted (0 never)
+  const unsigned int _compact_interval;
+  /// The sub-groups seen active in each top-level group, oldest first, with their time step
+  std::map<std::string, std::list<std::pair<int, std::string>>> & _retained_groups;
+  /// The number of markers carried over between time steps (0 for all survivors)
+  const unsigned int _marker_target;
+  /// The relative deviation from _marker_target that is tolerated
+  const Real _marker_target_tolerance;
+  /// The seed of the population control
+  const unsigned int _population_seed;
+  /// Whether the heat fluxes are averaged over all ASCOT5 runs so far
+  const bool _accumulate_tallies;
+  /// The variable receiving the relative error of the heat fluxes (empty for none)
+  const VariableName _error_var_name;
+  /// The relative error wanted on the hottest tiles (0 to keep the marker target fixed)
+  const Real _heat_flux_error_target;
+  /// The fraction of the largest heat flux above which tiles count as the hottest
+  const Real _hot_tile_fraction;
+  /// The number of markers carried over between time steps, rescaled by the error target
+  size_t & _current_marker_target;
+  /// The tile powers and sums of squares of the local tiles summed over the runs so far
+  std::vector<double_t> & _accumulated_power;
+  std::vector<double_t> & _accumulated_power_squared;
+  /// The number of runs summed in _accumulated_power
+  unsigned int & _accumulated_runs;
+  /// The quantities that can be tallied on each wall tile
+  enum class TallyQuantity
+  {
+    HeatFlux,
+    ParticleFlux,
+    MeanEnergy
+  };
+  /// The auxiliary variables receiving the tallies
+  const std::vector<VariableName> _tally_variables;
+  /// The quantity of each tally
+  std::vector<TallyQuantity> _tally_quantities;
+  /// The species counted by each tally
+  std::vector<AscotKernels::TallyFilter> _tally_filters;
+  /// The edges of the energy bins of the spectra in eV, and in Joules
+  const std::vector<Real> _spectrum_energies;
+  std::vector<double_t> _spectrum_edges;
+  /// The particle rate and power of each tally on each wall tile (only on ASCOT5 ranks)
+  std::vector<double_t> _tally_sums;
+  /// The particle rate of each tally in each energy bin (only on ASCOT5 ranks)
+  std::vector<double_t> _spectra;
+  /// The dofs of each tally variable on the local elements
+  std::vector<std::vector<dof_id_type>> _local_tally_dofs;
+  /// The tally values of each tally variable on the local elements
+  std::vector<std::vector<double_t>> _local_tally_values;
+  /// The largest marker id used so far
+  int64_t & _next_marker_id;
+  /// The endstate markers kept by the population control
+  std::vector<size_t> _population_indices;
+  /// The wall time of the last ASCOT5 run on this rank in seconds
+  double_t _ascot5_run_seconds;
+  /// The number of markers traced in the last ASCOT5 run on this rank
+  size_t _run_markers;
+  /// Statistics of the markers and HDF5 I/O on this rank
+  Statistics _statistics;
+  /// The number of markers per chunk of the marker datasets (0 for contiguous datasets)
+  const unsigned int _hdf5_chunk_size;
+  /// The deflate level of the marker datasets (0 for no compression)
+  const unsigned int _hdf5_compression_level;
+  /// The size in bytes of the chunk cache of each dataset
+  const unsigned int _hdf5_chunk_cache_size;
+  /// The number of slots of the chunk cache of each dataset
+  const unsigned int _hdf5_chunk_cache_slots;
+  /// The initial size in bytes of the metadata cache (0 for the HDF5 default)
+  const unsigned int _hdf5_metadata_cache_size;
+  /// Whether _ascot5_file is held in SWMR mode between ASCOT5 runs
+  const bool _swmr;
+  /// Whether _ascot5_file is open
+  bool _ascot5_file_open;
+  /// Whether _ascot5_file is in SWMR write mode
+  bool _ascot5_file_swmr;
+  /// The chunk size of compressed marker datasets when hdf5_chunk_size is not given
+  static const hsize_t default_chunk_size;
+  /// The groups that were active in ascot5_file before the simulation (only on the first rank)
+  std::set<std::string> _initial_groups;
+  /// Whether the mesh is written to ascot5_file as the ASCOT5 wall
+  const bool _export_wall;
+  /// The wall tiles (0-based) of each local element written by exportWall, with their areas
+  std::unordered_map<dof_id_type, std::vector<std::pair<dof_id_type, double_t>>> _exported_tiles;
+  /// Whether the wall tiles are mapped to the elements by their overlap
+  const bool _overlap_mapping;
+  /// The number of divisions of each wall triangle edge when sampling the overlaps
+  const unsigned int _mapping_refinement;
+  /// The largest distance between a wall triangle and the elements it overlaps in m
+  const Real _mapping_tolerance;
+  /// Name of the extra element integer holding the wall tile of each element (empty for ids)
+  const std::string _walltile_integer;
+  /// Whether the wall tile areas and dof map below are up to date with the mesh
+  bool _wall_tile_map_built;
+  /// The total number of wall tiles
+  dof_id_type _n_tiles;
+  /// The id of each local element
+  std::vector<dof_id_type> _local_elems;
+  /// The area of each local element in m^2
+  std::vector<double_t> _local_areas;
+  /// The sync_variable dof of each local element
+  std::vector<dof_id_type> _local_dofs;
+  /// The wall tiles (0-based) overlapping the local elements
+  std::vector<dof_id_type> _local_tiles;
+  /// The position of each wall tile in _local_tiles
+  std::unordered_map<dof_id_type, size_t> _local_tile_index;
+  /// The mapping from the tiles in _local_tiles to the local elements as a sparse (CSR) matrix:
+  /// element i takes the fraction _tile_map_fractions[k] of the power on tile
+  /// _local_tiles[_tile_map_tiles[k]] for k from _tile_map_offsets[i] to _tile_map_offsets[i + 1]
+  std::vector<size_t> _tile_map_offsets;
+  std::vector<size_t> _tile_map_tiles;
+  std::vector<double_t> _tile_map_fractions;
+  /// The error_variable dof of each local element
+  std::vector<dof_id_type> _local_error_dofs;
+  /// The heat fluxes of the local elements, in the order of _local_dofs
+  std::vector<double_t> _local_heat_fluxes;
+  /// The relative error of the heat fluxes of the local elements
+  std::vector<double_t> _local_relative_errors;
+  /// The power and the sum of the squared marker contributions on each local element in the last
+  /// run
+  std::vector<double_t> _local_power;
+  std::vector<double_t> _local_power_squared;
+  /// The ranks whose elements overlap each wall tile (only on ASCOT5 ranks), from
+  /// _tile_owner_ranks[_tile_owner_offsets[tile]] up to that of tile + 1
+  std::vector<size_t> _tile_owner_offsets;
+  std::vector<processor_id_type> _tile_owner_ranks;
+  /// The power incident on each wall tile in W from this rank's markers (only on ASCOT5 ranks)
+  std::vector<double_t> _tile_power;
+  /// The sum of the squared marker contributions to _tile_power in W^2 (only on ASCOT5 ranks)
+  std::vector<double_t> _tile_power_squared;
+  /// The number of markers per endstate block when streaming the endstate (0 reads it whole)
+  const size_t _endstate_block_size;
+  /// The endstate blocks being processed and read when streaming the endstate
+  std::array<AscotEndstate, 2> _endstate_blocks;
+  /// The power, tallies and active markers of the endstate block being processed
+  std::vector<double_t> _block_power;
+  std::vector<double_t> _block_power_squared;
+  std::vector<double_t> _block_tally_sums;
+  std::vector<double_t> _block_spectra;
+  std::vector<size_t> _block_indices;
+  std::vector<double_t> _block_hits;
+  /// The extra element integer the hits on each element are published to ("" for none)
+  const std::string _hit_weight_integer;
+  /// The index of _hit_weight_integer (libMesh::invalid_uint when hits are not published)
+  const unsigned int _hit_integer_index;
+  /// The number of markers hitting each wall tile from this rank (only on ASCOT5 ranks)
+  std::vector<double_t> _tile_hits;
+  /// The number of markers hitting each local element in the last run
+  std::vector<double_t> _local_hits;
+  /// The number of time steps between repartitions of the mesh (0 for none)
+  const unsigned int _repartition_interval;
+  /// The time step of the last repartition
+  int & _last_repartition_step;
   /// Mapping for top-level group name to sub-group prefix for ASCOT5 HDF5 file
   static const std::unordered_map<std::string, std::string> hdf5_group_prefix;
-  // The HDF5 dataset names that constitute the required endstate variables to restart ASCOT5
-  static const std::vector<std::string> endstate_fields_double;
-  static const std::vector<std::string> endstate_fields_int;
 };
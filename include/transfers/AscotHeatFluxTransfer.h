@@ -0,0 +1,74 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "MultiAppTransfer.h"
+#include <map>
+
+/**
+ * Transfers the heat fluxes of AscotProblem sub-apps to an elemental variable of the parent app,
+ * e.g. on a boundary of a heat conduction problem. The power on each sub-app element is shared
+ * between the parent elements (or their sides on the boundary) it overlaps in proportion to the
+ * overlap area, and divided by their area, so the power is conserved between different meshes.
+ * Only the elements with a nonzero heat flux are sent, and only to the ranks owning the parent
+ * elements they overlap, so the cost scales with the number of wall tiles hit rather than with
+ * the size of the mesh.
+ */
+class AscotHeatFluxTransfer : public MultiAppTransfer
+{
+public:
+  static InputParameters validParams();
+
+  AscotHeatFluxTransfer(const InputParameters & parameters);
+
+  virtual void initialSetup() override;
+
+  virtual void execute() override;
+
+protected:
+  /// A sub-app element, by sub-app and element id
+  typedef std::pair<unsigned int, dof_id_type> SubElement;
+
+  /**
+   * @brief Find the overlaps of the sub-app elements with the targets of this rank
+   *
+   * Each sub-app element is split into triangles, sent to the ranks whose parent elements they
+   * may overlap. Each triangle is split into mapping_refinement^2 equal sub-triangles, and the
+   * area of each is given to the target found under its centroid. The ranks of the sub-app
+   * elements are then told which ranks their power goes to.
+   */
+  void mapSubElements();
+
+  /// The elemental constant variable of the parent app the heat fluxes are written to
+  const AuxVariableName & _variable_name;
+  /// The boundaries whose sides receive the heat fluxes; empty for the parent elements themselves
+  const std::vector<BoundaryName> & _boundary;
+  /// The number of divisions of each sub-app triangle edge for sampling the overlap areas
+  const unsigned int _mapping_refinement;
+  /// The largest distance in m between a sub-app element and the parent elements it overlaps
+  const Real _mapping_tolerance;
+
+  /// The dof of each local parent element receiving heat fluxes (the targets)
+  std::vector<dof_id_type> _target_dofs;
+  /// The area of each target, or of its sides on the boundary
+  std::vector<Real> _target_areas;
+  /// The index of each sub-app element overlapping the targets in _overlap_offsets
+  std::map<SubElement, size_t> _sub_element_index;
+  /// The range of the overlaps of each sub-app element in _overlap_targets and _overlap_fractions
+  std::vector<size_t> _overlap_offsets;
+  /// The target of each overlap
+  std::vector<size_t> _overlap_targets;
+  /// The fraction of the sub-app element's area in each overlap
+  std::vector<Real> _overlap_fractions;
+  /// The ranks whose targets each local sub-app element overlaps
+  std::map<SubElement, std::vector<processor_id_type>> _destinations;
+  /// The targets set to a nonzero heat flux by the last transfer
+  std::vector<size_t> _nonzero_targets;
+};
@@ -0,0 +1,104 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Library-level entry points of the ASCOT5 build used by Phaethon (libascot_main) that go beyond
+ * the command line style ascot5_main. These are only available when ASCOT5 is built with the
+ * Phaethon library API, which is signalled by PHAETHON_ASCOT5_LIBRARY_API (see phaethon.mk).
+ */
+namespace ascot5
+{
+extern "C"
+{
+  /**
+   * Marker arrays handed to ASCOT5 in memory. Every array holds n values in the same units and
+   * layout as the datasets of an ASCOT5 HDF5 marker/prt_XXXXXXXXXX group, so ASCOT5 applies
+   * exactly the same conversions it would when reading that group from disk.
+   */
+  typedef struct
+  {
+    int64_t n;
+    const double * r;
+    const double * phi;
+    const double * z;
+    const double * vr;
+    const double * vphi;
+    const double * vz;
+    const double * mass;
+    const double * weight;
+    const double * time;
+    const int64_t * charge;
+    const int64_t * anum;
+    const int64_t * znum;
+    const int64_t * id;
+  } phaethon_marker_arrays;
+
+  /**
+   * An ASCOT5 run kept alive between time steps: the options, fields, plasma and wall (with its
+   * collision acceleration structures) of the input file stay resident, so each run only reads
+   * its markers.
+   */
+  typedef struct phaethon_session phaethon_session;
+
+  /// The inputs of a session, combined as flags to reload several at once
+  enum phaethon_session_input
+  {
+    PHAETHON_INPUT_OPTIONS = 1,
+    PHAETHON_INPUT_BFIELD = 2,
+    PHAETHON_INPUT_EFIELD = 4,
+    PHAETHON_INPUT_PLASMA = 8,
+    PHAETHON_INPUT_NEUTRAL = 16,
+    PHAETHON_INPUT_WALL = 32,
+    PHAETHON_INPUT_BOOZER = 64,
+    PHAETHON_INPUT_MHD = 128,
+    PHAETHON_INPUT_ASIGMA = 256
+  };
+
+#ifdef PHAETHON_ASCOT5_LIBRARY_API
+  /**
+   * Run ASCOT5 exactly as ascot5_main would, except that the markers are taken from the given
+   * arrays instead of the active marker group of the input file. In a multi-process run
+   * (--mpi_size and --mpi_rank) the arrays hold this process's share of the markers and are not
+   * split again.
+   */
+  int ascot5_main_markers(int argc, char ** argv, const phaethon_marker_arrays * markers);
+
+  /**
+   * Parse the arguments as ascot5_main does and load all the active inputs of the input file
+   * except the markers. Returns NULL on failure.
+   */
+  phaethon_session * ascot5_session_create(int argc, char ** argv);
+
+  /**
+   * Free the given inputs (a combination of phaethon_session_input flags) and load their active
+   * groups from the input file again. Returns 0 on success.
+   */
+  int ascot5_session_reload(phaethon_session * session, int inputs);
+
+  /**
+   * Trace markers up to max_simtime, overriding ENDCOND_MAX_SIMTIME of the resident options,
+   * and write the results as ascot5_main would for --in=input. The markers are taken from the
+   * given arrays, or from the active marker group of input if markers is NULL. A NULL input is
+   * the session's own input file; any other only supplies markers and receives results, so
+   * several marker sets can share one copy of the resident inputs. Returns 0 on success.
+   */
+  int ascot5_session_run(phaethon_session * session,
+                         double max_simtime,
+                         const phaethon_marker_arrays * markers,
+                         const char * input);
+
+  /// Free all the inputs of a session and the session itself
+  void ascot5_session_free(phaethon_session * session);
+#endif
+}
+}
@@ -0,0 +1,78 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "Ascot5Api.h"
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * The options, fields, plasma and wall of an ASCOT5 input file held in memory between runs, and
+ * reloaded only when their active groups change. A session is shared by all the AscotProblems in
+ * a process (e.g. the sibling MultiApps of an ensemble) that load the same inputs with the same
+ * ASCOT5 arguments, so the inputs are held once per process. Each problem may run its own markers
+ * from its own input file and get its own results there; the runs of a shared session take
+ * turns.
+ *
+ * The session needs ASCOT5 built with the Phaethon library API (see Ascot5Api.h).
+ */
+class Ascot5Session
+{
+public:
+  /**
+   * @brief Get the session of this process for the given inputs, loading them on first use
+   *
+   * @param input_file the ASCOT5 HDF5 file the inputs are read from
+   * @param arguments the ASCOT5 command line arguments, with --in naming input_file
+   * @return std::shared_ptr<Ascot5Session> the session, freed when its last user lets go of it
+   */
+  static std::shared_ptr<Ascot5Session> get(const std::string & input_file,
+                                            const std::vector<std::string> & arguments);
+
+  ~Ascot5Session();
+
+  /**
+   * @brief Reload the inputs whose active groups have changed and trace markers
+   *
+   * @param end_time the time up to which the markers are traced, overriding ENDCOND_MAX_SIMTIME
+   * @param markers the markers to trace, or nullptr to read the active marker group of input
+   * @param input the ASCOT5 input (as --in) the markers are read from and the results are
+   *        written to as ascot5_main would, or "" for the session's own input file
+   */
+  void run(double_t end_time,
+           const ascot5::phaethon_marker_arrays * markers,
+           const std::string & input = "");
+
+  /// The number of times the inputs have been loaded
+  std::size_t loads() const { return _loads; }
+
+private:
+  Ascot5Session(const std::string & input_file, const std::vector<std::string> & arguments);
+
+  /// Read the active group of each input from the input file ("" if there is none)
+  std::map<std::string, std::string> activeInputGroups() const;
+
+  /// The ASCOT5 input file
+  const std::string _input_file;
+  /// The ASCOT5 command line arguments the session was created with
+  const std::vector<std::string> _arguments;
+  /// The ASCOT5 session (nullptr until the first run)
+  ascot5::phaethon_session * _session;
+  /// The active group of each input when it was last loaded
+  std::map<std::string, std::string> _input_groups;
+  /// The number of times the inputs have been loaded
+  std::size_t _loads;
+  /// Held while the session loads inputs or traces markers
+  std::mutex _run_mutex;
+};
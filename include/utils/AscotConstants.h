@@ -0,0 +1,20 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include <cmath>
+
+/// Physical constants in SI units, as used by ASCOT5
+namespace constants
+{
+const double_t c = 299792458.0;
+const double_t amu = 1.6605390666e-27;
+const double_t e = 1.602176634e-19;
+}
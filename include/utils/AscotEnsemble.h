@@ -0,0 +1,47 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The in-process registry through which the members of an ensemble of AscotProblems (e.g. the
+ * sibling MultiApps of a parameter scan) report the tile powers of their last ASCOT5 runs to
+ * AscotEnsembleStatistics. Only the tiles a run deposited power on are kept.
+ */
+namespace AscotEnsemble
+{
+/// The (tile index, power in W) pairs of the tiles with nonzero power, in tile order
+typedef std::vector<std::pair<unsigned long, double_t>> SparseTilePower;
+
+/**
+ * @brief Record the tile power of this rank's share of an ensemble member's last run, replacing
+ * its previous run
+ *
+ * @param ensemble the name of the ensemble
+ * @param member the index of the member in the ensemble
+ * @param tile_power the power on each wall tile in W
+ */
+void recordMemberTilePower(const std::string & ensemble,
+                           unsigned int member,
+                           const std::vector<double_t> & tile_power);
+
+/**
+ * @brief The nonzero tile power recorded on this rank for each member of an ensemble
+ *
+ * @param ensemble the name of the ensemble
+ * @return std::map<unsigned int, SparseTilePower> the nonzero tile power of each member
+ */
+std::map<unsigned int, SparseTilePower> memberTilePower(const std::string & ensemble);
+}
@@ -0,0 +1,237 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "AscotMarkerStore.h"
+#include <algorithm>
+
+/**
+ * Batched kernels for post-processing ASCOT5 markers. They work on contiguous arrays so that the
+ * per-marker arithmetic vectorises, and are threaded with OpenMP when it is available. The scalar
+ * AscotProblem::calculateRelativisticEnergy is the reference implementation they are tested
+ * against.
+ */
+namespace AscotKernels
+{
+/**
+ * The species of markers a tally counts. A value of any_species matches all markers.
+ */
+struct TallyFilter
+{
+  static const int64_t any_species = -1;
+
+  /// The atomic mass number of the markers counted
+  int64_t anum = any_species;
+  /// The atomic number of the markers counted
+  int64_t znum = any_species;
+  /// The charge state of the markers counted
+  int64_t charge = any_species;
+
+  bool matches(int64_t marker_anum, int64_t marker_znum, int64_t marker_charge) const
+  {
+    return (anum == any_species || anum == marker_anum) &&
+           (znum == any_species || znum == marker_znum) &&
+           (charge == any_species || charge == marker_charge);
+  }
+};
+
+/**
+ * @brief Calculate the relativistic kinetic energies of a batch of markers
+ *
+ * @param n the number of markers
+ * @param mass the marker masses in amu
+ * @param vr the radial velocities in m/s
+ * @param vphi the toroidal velocities in m/s
+ * @param vz the vertical velocities in m/s
+ * @param energies the marker energies in Joules (output, n values)
+ */
+void calculateRelativisticEnergies(std::size_t n,
+                                   const double_t * mass,
+                                   const double_t * vr,
+                                   const double_t * vphi,
+                                   const double_t * vz,
+                                   double_t * energies);
+
+/**
+ * @brief Deposit the power carried by each marker into the wall tile it hit
+ *
+ * Fuses the energy calculation with the weighted scatter-add into the tiles, so that each marker
+ * is visited once. Markers with a walltile of 0 did not hit the wall and deposit nothing, as do
+ * markers whose walltile is beyond n_tiles.
+ *
+ * The tiles are split into contiguous ranges, one per thread, and each thread streams over all
+ * the markers and sums those that hit its own tiles straight into tile_power, without sorting
+ * the markers or private copies of the tiles. Each tile is summed in marker order, so the result
+ * is reproducible and does not depend on the number of threads.
+ *
+ * If tile_power_squared is given, the squares of the energy * weight contributions are summed
+ * into it in the same pass, for the statistical error of the tile powers (see relativeErrors).
+ *
+ * @param n the number of markers
+ * @param walltile the 1-based wall tile each marker hit, or 0
+ * @param mass the marker masses in amu
+ * @param vr the radial velocities in m/s
+ * @param vphi the toroidal velocities in m/s
+ * @param vz the vertical velocities in m/s
+ * @param weight the marker weights in markers/s
+ * @param n_tiles the number of wall tiles
+ * @param tile_power the power incident on each tile in W (output, n_tiles values)
+ * @param tile_power_squared the sum of the squared marker contributions to each tile in W^2
+ * (output, n_tiles values), or nullptr
+ */
+void depositPower(std::size_t n,
+                  const AscotMarkerField::walltile_type * walltile,
+                  const double_t * mass,
+                  const double_t * vr,
+                  const double_t * vphi,
+                  const double_t * vz,
+                  const AscotMarkerField::weight_type * weight,
+                  std::size_t n_tiles,
+                  double_t * tile_power,
+                  double_t * tile_power_squared = nullptr);
+
+/**
+ * @brief Deposit the power carried by the markers of an endstate into the wall tiles
+ *
+ * @param endstate the endstate markers
+ * @param tile_power the power incident on each tile in W; its size sets the number of tiles
+ */
+void depositPower(const AscotEndstate & endstate, std::vector<double_t> & tile_power);
+
+/**
+ * @brief Deposit the power of the markers of an endstate and the squares of their contributions
+ *
+ * @param endstate the endstate markers
+ * @param tile_power the power incident on each tile in W; its size sets the number of tiles
+ * @param tile_power_squared the sum of the squared marker contributions to each tile in W^2
+ * (resized to match tile_power)
+ */
+void depositPower(const AscotEndstate & endstate,
+                  std::vector<double_t> & tile_power,
+                  std::vector<double_t> & tile_power_squared);
+
+/**
+ * @brief Count the markers that hit each wall tile
+ *
+ * @param walltile the 1-based wall tile each marker hit, or 0
+ * @param tile_hits the number of markers on each tile; its size sets the number of tiles
+ */
+void countHits(const std::vector<AscotMarkerField::walltile_type> & walltile,
+               std::vector<double_t> & tile_hits);
+
+/**
+ * @brief Estimate the relative statistical error of tallies from their sums of squares
+ *
+ * Each marker is an independent sample, so the variance of a tally summed over the markers is
+ * estimated by the sum of its squared contributions, and its relative error by
+ * sqrt(sum of squares) / sum. Tallies that no marker contributed to have an error of 0.
+ *
+ * @param n the number of tallies
+ * @param tally the tallies
+ * @param tally_squared the sums of the squared contributions to each tally
+ * @param errors the relative error of each tally (output, n values)
+ */
+void relativeErrors(std::size_t n,
+                    const double_t * tally,
+                    const double_t * tally_squared,
+                    double_t * errors);
+
+/**
+ * @brief Tally the markers hitting the wall by species, per tile and by impact energy
+ *
+ * All tallies are filled in one pass over the markers. For each filter f and tile t,
+ * tile_sums[(2 * f) * n_tiles + t] is the particle rate (sum of the weights, in markers/s) and
+ * tile_sums[(2 * f + 1) * n_tiles + t] the power (sum of energy * weight, in W) of the markers
+ * that match the filter and hit the tile. From these the particle flux, heat flux and mean
+ * impact energy on each tile follow.
+ *
+ * For each filter f, spectra[f * n_bins + b] is the particle rate of the matching markers that
+ * hit the wall with an energy between energy_bin_edges[b] and energy_bin_edges[b + 1], where
+ * n_bins = energy_bin_edges.size() - 1. Energies outside the edges are not binned.
+ *
+ * The tiles are split between the threads as in depositPower, so the tile sums do not depend on
+ * the number of threads. Only the spectra, which do not scale with the number of tiles, are
+ * summed from private copies per thread, so they are reproducible for a given number of threads.
+ *
+ * @param endstate the endstate markers
+ * @param filters the species counted by each tally
+ * @param n_tiles the number of wall tiles
+ * @param energy_bin_edges the increasing edges of the energy bins in Joules (empty for none)
+ * @param tile_sums the particle rate and power of each filter on each tile (output)
+ * @param spectra the particle rate of each filter in each energy bin (output)
+ */
+void depositTallies(const AscotEndstate & endstate,
+                    const std::vector<TallyFilter> & filters,
+                    std::size_t n_tiles,
+                    const std::vector<double_t> & energy_bin_edges,
+                    std::vector<double_t> & tile_sums,
+                    std::vector<double_t> & spectra);
+
+/**
+ * @brief Select the markers with a given end condition
+ *
+ * Counts the matching markers first, so the indices are written in one pass without reallocating.
+ *
+ * @param endcond the end condition of each marker
+ * @param value the end condition to select
+ * @param indices the indices of the selected markers, in order (output)
+ */
+void selectMarkers(const std::vector<AscotMarkerField::endcond_type> & endcond,
+                   int64_t value,
+                   std::vector<std::size_t> & indices);
+
+/**
+ * @brief Split or roulette markers so that the population has exactly a target size
+ *
+ * Uses systematic resampling with equal expected copies c = target / n per marker: every marker
+ * is kept floor(c) or ceil(c) times, with ceil(c) times with probability frac(c). Scaling the
+ * weight of every copy by 1 / c therefore preserves the total weight (and any weighted tally) in
+ * expectation, and each marker's own weight exactly when c is a whole number.
+ *
+ * @param n the number of markers
+ * @param target the number of markers wanted
+ * @param seed the seed of the random offset of the systematic sampling
+ * @param indices the marker kept in each of the target slots, in nondecreasing order (output)
+ * @return double_t the factor 1 / c to scale the weight of every kept marker by
+ */
+double_t populationControl(std::size_t n,
+                           std::size_t target,
+                           uint64_t seed,
+                           std::vector<std::size_t> & indices);
+
+/**
+ * The comb of the systematic resampling in populationControl, so it can be applied to a stream of
+ * markers without holding the indices of all the target slots.
+ */
+struct PopulationComb
+{
+  /// The number of markers
+  std::size_t n = 0;
+  /// The random offset of the teeth, between 0 and 1
+  double_t offset = 0.0;
+  /// The distance between the teeth in markers, i.e. 1 / c, and the factor to scale weights by
+  double_t spacing = 1.0;
+
+  /// The marker kept in the given slot
+  std::size_t index(std::size_t slot) const
+  {
+    return std::min((std::size_t)((slot + offset) * spacing), n - 1);
+  }
+};
+
+/**
+ * @brief The comb populationControl resamples n markers to a target size with
+ *
+ * @param n the number of markers (at least 1)
+ * @param target the number of markers wanted (at least 1)
+ * @param seed the seed of the random offset of the systematic sampling
+ */
+PopulationComb populationComb(std::size_t n, std::size_t target, uint64_t seed);
+}
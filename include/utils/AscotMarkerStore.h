@@ -0,0 +1,351 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "DataIO.h"
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Tag types for the per-marker fields of the ASCOT5 endstate and marker groups. Each tag names
+ * the HDF5 dataset and the C++ type the field is stored as, which is also the type Phaethon writes
+ * the dataset as; HDF5 converts to and from the types of the datasets ASCOT5 reads and writes.
+ */
+namespace AscotMarkerField
+{
+/**
+ * The storage types of the fields that do not need the full width of the ASCOT5 datasets. They
+ * match the datasets by default. Building with PHAETHON_REDUCED_MARKER_PRECISION (see
+ * MARKER_PRECISION in phaethon.mk) narrows the species to 8 and 16 bits, the end condition to
+ * 16 bits and the wall tile to 32 bits, and stores the weight in single precision. The phase
+ * space coordinates, time, masses and ids are always kept in full, and energies and powers are
+ * always accumulated in double precision.
+ */
+#ifdef PHAETHON_REDUCED_MARKER_PRECISION
+typedef float weight_type;
+typedef int8_t charge_type;
+typedef int16_t anum_type;
+typedef int8_t znum_type;
+typedef int16_t endcond_type;
+typedef int32_t walltile_type;
+#else
+typedef double_t weight_type;
+typedef int64_t charge_type;
+typedef int64_t anum_type;
+typedef int64_t znum_type;
+typedef int64_t endcond_type;
+typedef int64_t walltile_type;
+#endif
+
+struct Mass
+{
+  static constexpr const char * name = "mass";
+  typedef double_t type;
+};
+struct R
+{
+  static constexpr const char * name = "rprt";
+  typedef double_t type;
+};
+struct Phi
+{
+  static constexpr const char * name = "phiprt";
+  typedef double_t type;
+};
+struct Z
+{
+  static constexpr const char * name = "zprt";
+  typedef double_t type;
+};
+struct VR
+{
+  static constexpr const char * name = "vr";
+  typedef double_t type;
+};
+struct VPhi
+{
+  static constexpr const char * name = "vphi";
+  typedef double_t type;
+};
+struct VZ
+{
+  static constexpr const char * name = "vz";
+  typedef double_t type;
+};
+struct Weight
+{
+  static constexpr const char * name = "weight";
+  typedef weight_type type;
+};
+struct Time
+{
+  static constexpr const char * name = "time";
+  typedef double_t type;
+};
+struct Id
+{
+  static constexpr const char * name = "id";
+  typedef int64_t type;
+};
+struct Charge
+{
+  static constexpr const char * name = "charge";
+  typedef charge_type type;
+};
+struct Anum
+{
+  static constexpr const char * name = "anum";
+  typedef anum_type type;
+};
+struct Znum
+{
+  static constexpr const char * name = "znum";
+  typedef znum_type type;
+};
+struct Endcond
+{
+  static constexpr const char * name = "endcond";
+  typedef endcond_type type;
+};
+struct Walltile
+{
+  static constexpr const char * name = "walltile";
+  typedef walltile_type type;
+};
+}
+
+/**
+ * Structure-of-arrays storage for ASCOT5 markers, with the list of fields fixed at compile time
+ * by the Fields tags. Every field is a contiguous std::vector of its own type, and all fields
+ * always hold the same number of markers. Resizing or clearing the store keeps the capacity of
+ * the buffers, so a store that is refilled every time step does not reallocate once it has
+ * reached its largest size.
+ */
+template <typename... Fields>
+class MarkerStore
+{
+public:
+  /// The storage type of a single field
+  template <typename Field>
+  using column_type = std::vector<typename Field::type>;
+
+  /// The number of fields in the store
+  static constexpr std::size_t n_fields = sizeof...(Fields);
+
+  /// The number of bytes of data per marker
+  static constexpr std::size_t bytes_per_marker = (sizeof(typename Fields::type) + ...);
+
+  /// Whether the store holds the given field
+  template <typename Field>
+  static constexpr bool hasField()
+  {
+    return index<Field>() < n_fields;
+  }
+
+  /**
+   * @brief Get the values of a field for all markers
+   *
+   * @tparam Field the field tag, e.g. AscotMarkerField::Weight
+   */
+  template <typename Field>
+  column_type<Field> & get()
+  {
+    static_assert(hasField<Field>(), "Field is not part of this MarkerStore");
+    return std::get<index<Field>()>(_columns);
+  }
+
+  template <typename Field>
+  const column_type<Field> & get() const
+  {
+    static_assert(hasField<Field>(), "Field is not part of this MarkerStore");
+    return std::get<index<Field>()>(_columns);
+  }
+
+  /**
+   * @brief Call f(Field(), column) for every field of the store, in the order of Fields
+   *
+   * The field tag is passed by value so that generic lambdas can recover the field (and its name
+   * and type) at compile time with decltype.
+   */
+  template <typename F>
+  void forEachField(F && f)
+  {
+    forEachFieldImpl(f, std::index_sequence_for<Fields...>());
+  }
+
+  template <typename F>
+  void forEachField(F && f) const
+  {
+    forEachFieldImpl(f, std::index_sequence_for<Fields...>());
+  }
+
+  /// The number of markers in the store
+  std::size_t size() const { return std::get<0>(_columns).size(); }
+
+  bool empty() const { return size() == 0; }
+
+  /// The memory held by the buffers of all fields in bytes
+  std::size_t capacityBytes() const
+  {
+    std::size_t bytes = 0;
+    forEachField([&bytes](auto, const auto & column) {
+      bytes += column.capacity() * sizeof(column[0]);
+    });
+    return bytes;
+  }
+
+  /// Resize all fields to n markers, keeping the buffers' capacity
+  void resize(std::size_t n)
+  {
+    forEachField([n](auto, auto & column) { column.resize(n); });
+  }
+
+  /// Remove all markers, keeping the buffers' capacity
+  void clear()
+  {
+    forEachField([](auto, auto & column) { column.clear(); });
+  }
+
+  /**
+   * @brief Set the store to the given markers of another store
+   *
+   * The same index map is applied to every field, one field at a time, so each field is read and
+   * written in a single pass.
+   *
+   * @param source a store holding (at least) all the fields of this store
+   * @param indices the markers of source to copy, in order; a marker may be repeated
+   */
+  template <typename Source>
+  void assign(const Source & source, const std::vector<std::size_t> & indices)
+  {
+    resize(indices.size());
+    forEachField([&source, &indices](auto field, auto & column) {
+      const auto & data = source.template get<decltype(field)>();
+      for (std::size_t j = 0; j < indices.size(); j++)
+      {
+        column[j] = data[indices[j]];
+      }
+    });
+  }
+
+  /**
+   * @brief Append the given markers of another store to the store
+   *
+   * @param source a store holding (at least) all the fields of this store
+   * @param indices the markers of source to append, in order
+   */
+  template <typename Source>
+  void append(const Source & source, const std::vector<std::size_t> & indices)
+  {
+    forEachField([&source, &indices](auto field, auto & column) {
+      const auto & data = source.template get<decltype(field)>();
+      for (auto && index : indices)
+      {
+        column.push_back(data[index]);
+      }
+    });
+  }
+
+private:
+  template <typename Field>
+  static constexpr std::size_t index()
+  {
+    constexpr bool matches[] = {std::is_same<Field, Fields>::value...};
+    for (std::size_t i = 0; i < n_fields; i++)
+    {
+      if (matches[i])
+      {
+        return i;
+      }
+    }
+    return n_fields;
+  }
+
+  template <typename F, std::size_t... I>
+  void forEachFieldImpl(F & f, std::index_sequence<I...>)
+  {
+    (f(Fields(), std::get<I>(_columns)), ...);
+  }
+
+  template <typename F, std::size_t... I>
+  void forEachFieldImpl(F & f, std::index_sequence<I...>) const
+  {
+    (f(Fields(), std::get<I>(_columns)), ...);
+  }
+
+  std::tuple<column_type<Fields>...> _columns;
+};
+
+/// The marker fields that ASCOT5 needs to start (or restart) a run
+typedef MarkerStore<AscotMarkerField::Mass,
+                    AscotMarkerField::R,
+                    AscotMarkerField::Phi,
+                    AscotMarkerField::Z,
+                    AscotMarkerField::VR,
+                    AscotMarkerField::VPhi,
+                    AscotMarkerField::VZ,
+                    AscotMarkerField::Weight,
+                    AscotMarkerField::Time,
+                    AscotMarkerField::Id,
+                    AscotMarkerField::Charge,
+                    AscotMarkerField::Anum,
+                    AscotMarkerField::Znum>
+    AscotMarkers;
+
+/// The endstate fields Phaethon reads after every ASCOT5 run
+typedef MarkerStore<AscotMarkerField::Mass,
+                    AscotMarkerField::R,
+                    AscotMarkerField::Phi,
+                    AscotMarkerField::Z,
+                    AscotMarkerField::VR,
+                    AscotMarkerField::VPhi,
+                    AscotMarkerField::VZ,
+                    AscotMarkerField::Weight,
+                    AscotMarkerField::Time,
+                    AscotMarkerField::Id,
+                    AscotMarkerField::Charge,
+                    AscotMarkerField::Anum,
+                    AscotMarkerField::Znum,
+                    AscotMarkerField::Endcond,
+                    AscotMarkerField::Walltile>
+    AscotEndstate;
+
+/**
+ * Restartable data support for MarkerStore. Each field is written as one raw block of bytes, so
+ * storing and loading take time linear in the number of markers.
+ */
+template <typename... Fields>
+inline void
+dataStore(std::ostream & stream, MarkerStore<Fields...> & store, void * /*context*/)
+{
+  uint64_t n_markers = store.size();
+  stream.write(reinterpret_cast<const char *>(&n_markers), sizeof(n_markers));
+  store.forEachField([&stream, n_markers](auto, const auto & column) {
+    stream.write(reinterpret_cast<const char *>(column.data()), n_markers * sizeof(column[0]));
+  });
+}
+
+template <typename... Fields>
+inline void
+dataLoad(std::istream & stream, MarkerStore<Fields...> & store, void * /*context*/)
+{
+  uint64_t n_markers = 0;
+  stream.read(reinterpret_cast<char *>(&n_markers), sizeof(n_markers));
+  store.resize(n_markers);
+  store.forEachField([&stream, n_markers](auto, auto & column) {
+    stream.read(reinterpret_cast<char *>(column.data()), n_markers * sizeof(column[0]));
+  });
+}
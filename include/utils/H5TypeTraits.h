@@ -0,0 +1,56 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "H5Cpp.h"
+#include <cstdint>
+
+/**
+ * Compile-time mapping from C++ types to the native HDF5 types they are read and written as.
+ * Types without a specialisation fail to compile, rather than failing at run time.
+ */
+template <typename T>
+struct H5TypeTraits;
+
+template <>
+struct H5TypeTraits<double>
+{
+  static const H5::PredType & type() { return H5::PredType::NATIVE_DOUBLE; }
+};
+
+template <>
+struct H5TypeTraits<float>
+{
+  static const H5::PredType & type() { return H5::PredType::NATIVE_FLOAT; }
+};
+
+template <>
+struct H5TypeTraits<int64_t>
+{
+  static const H5::PredType & type() { return H5::PredType::NATIVE_INT64; }
+};
+
+template <>
+struct H5TypeTraits<int32_t>
+{
+  static const H5::PredType & type() { return H5::PredType::NATIVE_INT32; }
+};
+
+template <>
+struct H5TypeTraits<int16_t>
+{
+  static const H5::PredType & type() { return H5::PredType::NATIVE_INT16; }
+};
+
+template <>
+struct H5TypeTraits<int8_t>
+{
+  static const H5::PredType & type() { return H5::PredType::NATIVE_INT8; }
+};
@@ -0,0 +1,38 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "GeneralVectorPostprocessor.h"
+
+class AscotProblem;
+
+/**
+ * Reports the energy spectra of the markers hitting the wall in the last ASCOT5 run of an
+ * AscotProblem, one vector per tally variable, tallied in the same pass as the tallies.
+ */
+class AscotEnergySpectrum : public GeneralVectorPostprocessor
+{
+public:
+  static InputParameters validParams();
+
+  AscotEnergySpectrum(const InputParameters & parameters);
+
+  virtual void initialize() override {}
+  virtual void execute() override;
+  virtual void finalize() override;
+
+protected:
+  /// The problem the spectra are taken from
+  const AscotProblem * const _ascot_problem;
+  /// The centre of each energy bin in eV
+  VectorPostprocessorValue & _energy;
+  /// The particle rate in each energy bin in markers/s, for each tally
+  std::vector<VectorPostprocessorValue *> _spectra;
+};
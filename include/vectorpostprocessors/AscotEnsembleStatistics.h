@@ -0,0 +1,47 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "GeneralVectorPostprocessor.h"
+#include "AscotEnsemble.h"
+
+/**
+ * Reports the mean and standard deviation over the members of an ensemble of the power on each
+ * wall tile hit in their last ASCOT5 runs. The members are the AscotProblems naming the given
+ * ensemble in the processes of this object's app, e.g. its sibling MultiApps.
+ *
+ * The statistics of each tile are taken on the rank owning it, to which the members only send the
+ * tiles they hit. The tile vectors are gathered onto the first rank.
+ */
+class AscotEnsembleStatistics : public GeneralVectorPostprocessor
+{
+public:
+  static InputParameters validParams();
+
+  AscotEnsembleStatistics(const InputParameters & parameters);
+
+  virtual void initialize() override {}
+  virtual void execute() override;
+  virtual void finalize() override;
+
+protected:
+  /// The name of the ensemble
+  const std::string & _ensemble;
+  /// The number of members that have reported a run
+  VectorPostprocessorValue & _members;
+  /// The 1-based ids of the wall tiles hit by any member
+  VectorPostprocessorValue & _tile;
+  /// The mean tile power over the members in W
+  VectorPostprocessorValue & _mean_power;
+  /// The standard deviation of the tile power over the members in W
+  VectorPostprocessorValue & _power_standard_deviation;
+  /// The nonzero tile power of each member on this rank
+  std::map<unsigned int, AscotEnsemble::SparseTilePower> _member_tile_power;
+};
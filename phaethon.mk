@@ -10,6 +10,10 @@ ADDITIONAL_INCLUDES += -I/usr/include/hdf5/serial
 ADDITIONAL_LIBS     += -lhdf5_hl_cpp -lhdf5_cpp -lhdf5_serial_hl -lhdf5_serial
 endif
 
+# OpenMP for the batched marker post-processing kernels
+libmesh_CXXFLAGS    += -fopenmp
+ADDITIONAL_LIBS     += -fopenmp
+
 # ASCOT5
 ASCOT5_DIR := $(APPLICATION_DIR)/ascot5
 ADDITIONAL_DEPEND_LIBS += libascot_main
@@ -17,5 +21,20 @@ ADDITIONAL_LIBS += -Wl,-rpath=$(ASCOT5_DIR) -L$(ASCOT5_DIR) -lascot_main
 ADDITIONAL_INCLUDES += -I$(ASCOT5_DIR)/include
 ASCOT5_OPT := NOGIT=true CC=h5cc MPI=0 FLAGS=-foffload=disable
 
+# Set to yes when the ASCOT5 checkout exports the Phaethon library API (see
+# include/utils/Ascot5Api.h), e.g. for the in-memory marker handoff and the
+# persistent ASCOT5 session
+ASCOT5_LIBRARY_API ?= no
+ifeq ($(ASCOT5_LIBRARY_API),yes)
+ADDITIONAL_CPPFLAGS += -DPHAETHON_ASCOT5_LIBRARY_API
+endif
+
+# Set to reduced to store the non-kinematic marker fields in narrower types (see
+# include/utils/AscotMarkerStore.h), which cuts endstate memory and restart I/O
+MARKER_PRECISION ?= full
+ifeq ($(MARKER_PRECISION),reduced)
+ADDITIONAL_CPPFLAGS += -DPHAETHON_REDUCED_MARKER_PRECISION
+endif
+
 libascot_main:
 	$(MAKE) $(ASCOT5_OPT) -C $(ASCOT5_DIR) libascot_main
@@ -0,0 +1,71 @@
+[Mesh]
+  type = FileMesh
+  file = 'simple_run.inp'
+  allow_renumbering = false
+[]
+
+[Problem]
+  solve = false
+  kernel_coverage_check = false
+[]
+
+[AuxVariables]
+  [fi_heat_flux]
+    family = MONOMIAL
+    order = CONSTANT
+  []
+[]
+
+[MultiApps]
+  [ascot]
+    type = TransientMultiApp
+    input_files = 'ascotproblem_multi_timestep.i'
+    execute_on = timestep_begin
+    cli_args = 'Postprocessors/power/type=ElementIntegralVariablePostprocessor '
+               'Postprocessors/power/variable=fi_heat_flux'
+  []
+[]
+
+[Transfers]
+  [heat_flux]
+    type = AscotHeatFluxTransfer
+    from_multi_app = ascot
+    variable = fi_heat_flux
+  []
+  [power]
+    type = MultiAppPostprocessorTransfer
+    from_multi_app = ascot
+    from_postprocessor = power
+    to_postprocessor = ascot_power
+    reduction_type = sum
+  []
+[]
+
+[Postprocessors]
+  [power]
+    type = ElementIntegralVariablePostprocessor
+    variable = fi_heat_flux
+    outputs = csv
+  []
+  [ascot_power]
+    type = Receiver
+    outputs = csv
+  []
+  [power_error]
+    type = RelativeDifferencePostprocessor
+    value1 = power
+    value2 = ascot_power
+    outputs = csv
+  []
+[]
+
+[Executioner]
+  type = Transient
+  dt = 1e-6
+  num_steps = 5
+[]
+
+[Outputs]
+  exodus = true
+  csv = true
+[]
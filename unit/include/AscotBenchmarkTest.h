@@ -0,0 +1,97 @@
+#pragma once
+
+#include "AscotProblemTest.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Fixture to time the data paths of the Ascot External Problem on synthetic endstates. The
+// benchmarks only run when PHAETHON_BENCHMARK is set; they are configured with
+//   PHAETHON_BENCHMARK_MARKERS  comma-separated marker counts (default 1e4,1e5,1e6)
+//   PHAETHON_BENCHMARK_TILES    comma-separated wall tile counts (default 1e3,1e5)
+//   PHAETHON_BENCHMARK_REPEATS  repeats of each timing, of which the fastest is kept (default 3)
+//   PHAETHON_BENCHMARK_OUTPUT   the file the results are appended to, one JSON object per line
+//                               (default benchmark.json)
+// The heat flux, power distribution and sync benchmarks run on the wall tiles of the test mesh.
+class AscotBenchmarkTest : public AscotProblemTest
+{
+protected:
+  AscotBenchmarkTest() : AscotProblemTest("ascot_hdf5.i"){};
+
+  virtual void SetUp() override
+  {
+    if (enabled())
+    {
+      AscotProblemTest::SetUp();
+    }
+  }
+
+  static bool enabled() { return std::getenv("PHAETHON_BENCHMARK") != nullptr; }
+
+  static std::vector<size_t> sizes(const char * variable, const std::string & defaults)
+  {
+    const char * value = std::getenv(variable);
+    std::stringstream list(value ? value : defaults);
+    std::vector<size_t> result;
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+      result.push_back(std::stod(item));
+    }
+    return result;
+  }
+
+  static std::vector<size_t> markerCounts()
+  {
+    return sizes("PHAETHON_BENCHMARK_MARKERS", "1e4,1e5,1e6");
+  }
+
+  static std::vector<size_t> tileCounts() { return sizes("PHAETHON_BENCHMARK_TILES", "1e3,1e5"); }
+
+  // The fastest of the repeated runs of f in seconds; setup (not timed) runs before each repeat
+  template <typename F, typename S>
+  static double_t time(F && f, S && setup)
+  {
+    const char * value = std::getenv("PHAETHON_BENCHMARK_REPEATS");
+    const unsigned int repeats = value ? std::stoul(value) : 3;
+    double_t fastest = std::numeric_limits<double_t>::max();
+    for (unsigned int i = 0; i < repeats; i++)
+    {
+      setup();
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const auto end = std::chrono::steady_clock::now();
+      fastest = std::min(fastest, std::chrono::duration<double_t>(end - start).count());
+    }
+    return fastest;
+  }
+
+  template <typename F>
+  static double_t time(F && f)
+  {
+    return time(f, []() {});
+  }
+
+  // Append one timing to the results file
+  static void
+  record(const std::string & path, size_t n_markers, size_t n_tiles, double_t seconds)
+  {
+    const char * value = std::getenv("PHAETHON_BENCHMARK_OUTPUT");
+    std::ofstream output(value ? value : "benchmark.json", std::ios::app);
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    output << "{\"path\": \"" << path << "\", \"markers\": " << n_markers
+           << ", \"tiles\": " << n_tiles << ", \"threads\": " << threads
+           << ", \"seconds\": " << seconds
+           << ", \"markers_per_second\": " << (seconds > 0.0 ? n_markers / seconds : 0.0) << "}"
+           << std::endl;
+  }
+
+  const std::string synthetic_file_name = "synthetic_endstate_benchmark.h5";
+};
@@ -0,0 +1,45 @@
+//* This file is part of the MOOSE framework
+//* https://www.mooseframework.org
+//*
+//* All rights reserved, see COPYRIGHT for full restrictions
+//* https://github.com/idaholab/moose/blob/master/COPYRIGHT
+//*
+//* Licensed under LGPL 2.1, please see LICENSE for details
+//* https://www.gnu.org/licenses/lgpl-2.1.html
+
+#pragma once
+
+#include "AscotMarkerStore.h"
+#include <string>
+
+/**
+ * Generators of synthetic ASCOT5 endstates, for tests and benchmarks that must not depend on
+ * ASCOT5 having run.
+ */
+namespace SyntheticEndstate
+{
+/**
+ * @brief Fill an endstate with reproducible pseudo-random alpha particle markers
+ *
+ * About half the markers are still active (endcond 1), a third hit the wall (endcond 8, with a
+ * walltile between 1 and n_tiles) and the rest have thermalised (endcond 4). Markers that did
+ * not hit the wall have a walltile of 0. Ids run from 1 to n_markers.
+ *
+ * @param endstate the endstate to fill
+ * @param n_markers the number of markers
+ * @param n_tiles the number of wall tiles
+ * @param seed the seed of the random numbers
+ */
+void generate(AscotEndstate & endstate, size_t n_markers, size_t n_tiles, uint64_t seed = 42);
+
+/**
+ * @brief Write an ASCOT5 HDF5 file holding an endstate as its active results
+ *
+ * The file has the layout AscotProblem expects: active options, marker and results groups, with
+ * ENDCOND_MAX_SIMTIME in the options and the endstate in results/run_XXXXXXXXXX/endstate.
+ *
+ * @param file_name the file to create (overwritten if it exists)
+ * @param endstate the endstate to write
+ */
+void writeFile(const std::string & file_name, const AscotEndstate & endstate);
+}